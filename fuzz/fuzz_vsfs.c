@@ -0,0 +1,492 @@
+/*
+ * RAVEN VSFS: Fuzzing and differential-test harness
+ *
+ * Feeds (mutated, possibly truncated) filesystem images through the check and
+ * repair paths of raven_vsfs.c in-process and compares the results against a simple
+ * reference checker that decodes the raw image bytes on its own.
+ * Any disagreement, or a repair that leaves the image inconsistent, aborts.
+ *
+ * Build modes:
+ *   libFuzzer:  clang -fsanitize=fuzzer,address,undefined ...    (make fuzz)
+ *   standalone: gcc -fsanitize=address,undefined ...            (make fuzz-standalone)
+ *
+ * The standalone binary replays files given on the command line (AFL: @@),
+ * or with -n runs its own mutation loop and reports exec/sec.
+ */
+
+ #define _POSIX_C_SOURCE 200809L         // ftruncate, fileno, clock_gettime
+ #define RAVEN_VSFS_NO_MAIN
+ #define REPORT_FINDING(kind, a, b, c) record_finding((kind), (a), (b), (c))
+
+ static void record_finding(int kind, int a, int b, int c);
+
+ #include "../raven_vsfs.c"
+
+ #include <time.h>
+ #include <unistd.h>                     // ftruncate
+
+ #define IMAGE_SIZE (TOTAL_BLOCKS * BLOCK_SIZE)
+ #define METADATA_SIZE (DATA_BLOCK_START * BLOCK_SIZE)   // only blocks 0-7 are parsed
+ #define SUPERBLOCK_FIELDS 9
+ #define POINTER_SLOTS 4                 // direct, single, double, triple indirect
+ #define MAX_FINDINGS (SUPERBLOCK_FIELDS + INODE_COUNT + DATA_BLOCK_COUNT + 2 * POINTER_SLOTS * INODE_COUNT)
+
+ // One reported inconsistency, see REPORT_FINDING in raven_vsfs.c
+ typedef struct {
+     int kind;
+     int a;
+     int b;
+     int c;
+ } Finding;
+
+ typedef struct {
+     int count;
+     Finding items[MAX_FINDINGS];
+ } Findings;
+
+ static const char *kind_names[] = { "superblock", "inode bitmap", "data bitmap", "duplicate", "bad block" };
+
+ static uint8_t image[IMAGE_SIZE];
+ static FILE *scratch;                   // real file, so truncated images behave as on disk
+ static Findings *recording;             // where record_finding() appends, NULL when not checking
+
+ static void add_finding(Findings *f, int kind, int a, int b, int c) {
+     if (f->count >= MAX_FINDINGS) {
+         fprintf(stderr, "Too many findings (%d)\n", f->count);
+         abort();
+     }
+     Finding item = { kind, a, b, c };
+     f->items[f->count++] = item;
+ }
+
+ static void record_finding(int kind, int a, int b, int c) {
+     if (recording) {
+         add_finding(recording, kind, a, b, c);
+     }
+ }
+
+ static int count_kind(const Findings *f, int kind) {
+     int n = 0;
+     for (int i = 0; i < f->count; i++) {
+         if (f->items[i].kind == kind) {
+             n++;
+         }
+     }
+     return n;
+ }
+
+ // ---------------------------------------------------------------------------
+ // Reference checker: byte-level decoding, no shared state with raven_vsfs.c
+ // ---------------------------------------------------------------------------
+
+ static uint32_t ref_u16(const uint8_t *p) {
+     return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+ }
+
+ static uint32_t ref_u32(const uint8_t *p) {
+     return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+ }
+
+ static const uint8_t *ref_inode(const uint8_t *img_buf, int i) {
+     return img_buf + (INODE_TABLE_START_BLOCK + i / INODES_PER_BLOCK) * BLOCK_SIZE
+                    + (i % INODES_PER_BLOCK) * INODE_SIZE;
+ }
+
+ static bool ref_inode_valid(const uint8_t *ino) {
+     return ref_u32(ino + 32) > 0 && ref_u32(ino + 28) == 0;    // links_count, dtime
+ }
+
+ static bool ref_bit(const uint8_t *bitmap, int bit) {
+     return (bitmap[bit / 8] >> (bit % 8)) & 1;
+ }
+
+ // Findings in the order the checks run; blocks report the first owner for
+ // duplicates and the last owner for the data bitmap, as the checker does
+ static void reference_check(const uint8_t *img_buf, Findings *out) {
+     const uint8_t *s = img_buf + SUPERBLOCK_BLOCK * BLOCK_SIZE;
+     const uint32_t expected[SUPERBLOCK_FIELDS - 1] = {
+         BLOCK_SIZE, TOTAL_BLOCKS, INODE_BITMAP_BLOCK, DATA_BITMAP_BLOCK,
+         INODE_TABLE_START_BLOCK, DATA_BLOCK_START, INODE_SIZE, INODE_COUNT
+     };
+
+     out->count = 0;
+     if (ref_u16(s) != SUPERBLOCK_MAGIC) {
+         add_finding(out, FINDING_SUPERBLOCK, 0, 0, 0);
+     }
+     for (int f = 0; f < SUPERBLOCK_FIELDS - 1; f++) {
+         if (ref_u32(s + 2 + 4 * f) != expected[f]) {
+             add_finding(out, FINDING_SUPERBLOCK, f + 1, 0, 0);
+         }
+     }
+
+     const uint8_t *ibm = img_buf + INODE_BITMAP_BLOCK * BLOCK_SIZE;
+     const uint8_t *dbm = img_buf + DATA_BITMAP_BLOCK * BLOCK_SIZE;
+     int first_owner[TOTAL_BLOCKS];
+     int last_owner[TOTAL_BLOCKS];
+     for (int b = 0; b < TOTAL_BLOCKS; b++) {
+         first_owner[b] = -1;
+         last_owner[b] = -1;
+     }
+
+     for (int i = 0; i < INODE_COUNT; i++) {
+         const uint8_t *ino = ref_inode(img_buf, i);
+         bool valid = ref_inode_valid(ino);
+
+         if (valid != ref_bit(ibm, i)) {
+             add_finding(out, FINDING_INODE_BITMAP, i, !valid, 0);
+         }
+         if (!valid) {
+             continue;
+         }
+
+         // block pointers at offsets 40..52
+         for (int p = 0; p < POINTER_SLOTS; p++) {
+             uint32_t blk = ref_u32(ino + 40 + 4 * p);
+             if (blk == 0) {
+                 continue;
+             }
+             if (blk < DATA_BLOCK_START || blk >= TOTAL_BLOCKS) {
+                 add_finding(out, FINDING_BAD_BLOCK, i, p, 0);
+             } else if (first_owner[blk] >= 0) {
+                 add_finding(out, FINDING_DUPLICATE, i, p, first_owner[blk]);
+             } else {
+                 first_owner[blk] = i;
+             }
+             if (blk >= DATA_BLOCK_START && blk < TOTAL_BLOCKS) {
+                 last_owner[blk] = i;
+             }
+         }
+     }
+
+     for (int b = DATA_BLOCK_START; b < TOTAL_BLOCKS; b++) {
+         if ((last_owner[b] >= 0) != ref_bit(dbm, b - DATA_BLOCK_START)) {
+             add_finding(out, FINDING_DATA_BITMAP, b, last_owner[b], 0);
+         }
+     }
+ }
+
+ // ---------------------------------------------------------------------------
+ // Checker under test
+ // ---------------------------------------------------------------------------
+
+ static void reset_checker_state(void) {
+     memset(inode_referenced, 0, sizeof(inode_referenced));
+     memset(data_block_referenced, 0, sizeof(data_block_referenced));
+     memset(data_block_owner, -1, sizeof(data_block_owner));
+     errors_found = 0;
+     errors_fixed = 0;
+ }
+
+ static void expect_count(const char *stage, int kind, int returned, const Findings *f) {
+     if (returned != count_kind(f, kind)) {
+         fprintf(stderr, "MISMATCH (%s): %s check returned %d but reported %d findings\n",
+                 stage, kind_names[kind], returned, count_kind(f, kind));
+         abort();
+     }
+ }
+
+ // Same order as main(): the data bitmap check relies on check_inode_bitmap()
+ static void run_checks(const char *stage, Findings *out) {
+     out->count = 0;
+     recording = out;
+     expect_count(stage, FINDING_SUPERBLOCK, check_superblock(), out);
+     expect_count(stage, FINDING_INODE_BITMAP, check_inode_bitmap(), out);
+     expect_count(stage, FINDING_DATA_BITMAP, check_data_bitmap(), out);
+     expect_count(stage, FINDING_DUPLICATE, check_duplicate_blocks(), out);
+     expect_count(stage, FINDING_BAD_BLOCK, check_bad_blocks(), out);
+     recording = NULL;
+ }
+
+ static int compare_findings(const void *x, const void *y) {
+     const Finding *p = x;
+     const Finding *q = y;
+     if (p->kind != q->kind) {
+         return p->kind < q->kind ? -1 : 1;
+     }
+     if (p->a != q->a) {
+         return p->a < q->a ? -1 : 1;
+     }
+     if (p->b != q->b) {
+         return p->b < q->b ? -1 : 1;
+     }
+     if (p->c != q->c) {
+         return p->c < q->c ? -1 : 1;
+     }
+     return 0;
+ }
+
+ static void print_finding(const char *side, const Finding *f) {
+     fprintf(stderr, "  only in %s: %s (%d, %d, %d)\n", side, kind_names[f->kind], f->a, f->b, f->c);
+ }
+
+ // Compares the findings as sets and prints both differences on a mismatch
+ static void expect_findings(const char *stage, Findings *got, Findings *want) {
+     qsort(got->items, got->count, sizeof(Finding), compare_findings);
+     qsort(want->items, want->count, sizeof(Finding), compare_findings);
+     if (got->count == want->count
+             && memcmp(got->items, want->items, got->count * sizeof(Finding)) == 0) {
+         return;
+     }
+
+     fprintf(stderr, "MISMATCH (%s): %d findings from checker, %d from reference\n",
+             stage, got->count, want->count);
+     int i = 0, j = 0;
+     while (i < got->count || j < want->count) {
+         int cmp = i == got->count ? 1
+                 : j == want->count ? -1
+                 : compare_findings(&got->items[i], &want->items[j]);
+         if (cmp < 0) {
+             print_finding("checker", &got->items[i++]);
+         } else if (cmp > 0) {
+             print_finding("reference", &want->items[j++]);
+         } else {
+             i++;
+             j++;
+         }
+     }
+     abort();
+ }
+
+ // Repairs only cover the superblock and bitmaps
+ static void keep_unrepaired(const Findings *in, Findings *out) {
+     out->count = 0;
+     for (int i = 0; i < in->count; i++) {
+         if (in->items[i].kind == FINDING_DUPLICATE || in->items[i].kind == FINDING_BAD_BLOCK) {
+             out->items[out->count++] = in->items[i];
+         }
+     }
+ }
+
+ // One execution: check, repair, re-check, and verify what was written back
+ static void run_one(const uint8_t *data, size_t size) {
+     static Findings want, repaired, got, on_disk;
+
+     if (size > IMAGE_SIZE) {
+         size = IMAGE_SIZE;
+     }
+     // The reference sees the image zero-padded, which is how read_block() treats a short file
+     memset(image, 0, sizeof(image));
+     memcpy(image, data, size);
+
+     reference_check(image, &want);
+     keep_unrepaired(&want, &repaired);
+
+     // The checker sees exactly `size` bytes
+     if (!scratch && !(scratch = tmpfile())) {
+         perror("tmpfile");
+         abort();
+     }
+     if (ftruncate(fileno(scratch), 0) != 0) {
+         perror("ftruncate");
+         abort();
+     }
+     rewind(scratch);
+     if (fwrite(data, 1, size, scratch) != size || fflush(scratch) != 0) {
+         perror("fwrite");
+         abort();
+     }
+     img = scratch;
+     reset_checker_state();
+
+     load_image();
+
+     run_checks("initial check", &got);
+     expect_findings("initial check", &got, &want);
+
+     fix_superblock();
+     fix_inode_bitmap();
+     fix_data_bitmap();
+
+     errors_found = 0;
+     run_checks("re-check after repair", &got);
+     expect_findings("re-check after repair", &got, &repaired);
+
+     // Read back what the repairs wrote; writes past the end extend the file with zeros
+     fflush(img);
+     memset(image, 0, sizeof(image));
+     rewind(img);
+     if (fread(image, 1, IMAGE_SIZE, img) == 0 && ferror(img)) {
+         perror("fread");
+         abort();
+     }
+     img = NULL;
+     reference_check(image, &on_disk);
+     expect_findings("repaired image on disk", &on_disk, &repaired);
+ }
+
+ static void quiet_stdout(void) {
+     static bool done = false;
+     if (!done) {
+         if (!freopen("/dev/null", "w", stdout)) {
+             perror("freopen");
+         }
+         done = true;
+     }
+ }
+
+ #ifdef RAVEN_VSFS_LIBFUZZER
+
+ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+     quiet_stdout();
+     run_one(data, size);
+     return 0;
+ }
+
+ #else
+
+ // ---------------------------------------------------------------------------
+ // Standalone driver
+ // ---------------------------------------------------------------------------
+
+ static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+ static uint32_t rng_next(void) {                    // xorshift64
+     rng_state ^= rng_state << 13;
+     rng_state ^= rng_state >> 7;
+     rng_state ^= rng_state << 17;
+     return (uint32_t)(rng_state >> 32);
+ }
+
+ // Values that sit on the edges of the checker's range tests
+ static const uint32_t interesting[] = {
+     0, 1, DATA_BLOCK_START - 1, DATA_BLOCK_START, TOTAL_BLOCKS - 1, TOTAL_BLOCKS,
+     SUPERBLOCK_MAGIC, BLOCK_SIZE, INODE_COUNT, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF,
+     DATA_BITMAP_BLOCK, INODE_TABLE_START_BLOCK, INODE_SIZE
+ };
+
+ static uint32_t pick_interesting(void) {
+     return interesting[rng_next() % (sizeof(interesting) / sizeof(interesting[0]))];
+ }
+
+ static void store_le(uint8_t *buf, uint32_t off, uint32_t v, int width) {
+     for (int k = 0; k < width; k++) {
+         buf[off + k] = (uint8_t)(v >> (8 * k));
+     }
+ }
+
+ static void mutate(uint8_t *buf) {
+     int rounds = 1 + rng_next() % 8;
+     for (int r = 0; r < rounds; r++) {
+         uint32_t off = rng_next() % METADATA_SIZE;
+         switch (rng_next() % 6) {
+             case 0:                                 // flip one bit
+                 buf[off] ^= (uint8_t)(1u << (rng_next() % 8));
+                 break;
+             case 1:                                 // random byte
+                 buf[off] = (uint8_t)rng_next();
+                 break;
+             case 2:                                 // interesting 32-bit value
+                 store_le(buf, off & ~3u, pick_interesting(), 4);
+                 break;
+             case 3:                                 // interesting value in dtime/links_count/blocks_count/block pointers
+                 off = INODE_TABLE_START_BLOCK * BLOCK_SIZE + (rng_next() % INODE_COUNT) * INODE_SIZE
+                       + 28 + 4 * (rng_next() % 7);
+                 store_le(buf, off, pick_interesting(), 4);
+                 break;
+             case 4: {                               // interesting value in a superblock field
+                 int field = rng_next() % SUPERBLOCK_FIELDS;
+                 if (field == 0) {
+                     store_le(buf, 0, pick_interesting(), 2);    // 16-bit magic
+                 } else {
+                     store_le(buf, 2 + 4 * (field - 1), pick_interesting(), 4);
+                 }
+                 break;
+             }
+             default: {                              // copy one inode over another
+                 int from = rng_next() % INODE_COUNT;
+                 int to = rng_next() % INODE_COUNT;
+                 memmove(buf + (INODE_TABLE_START_BLOCK * BLOCK_SIZE) + to * INODE_SIZE,
+                         buf + (INODE_TABLE_START_BLOCK * BLOCK_SIZE) + from * INODE_SIZE, INODE_SIZE);
+                 break;
+             }
+         }
+     }
+ }
+
+ static size_t load_file(const char *path, uint8_t *buf) {
+     FILE *f = fopen(path, "rb");
+     if (!f) {
+         perror(path);
+         exit(1);
+     }
+     size_t n = fread(buf, 1, IMAGE_SIZE, f);
+     fclose(f);
+     return n;
+ }
+
+ static double now_seconds(void) {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return ts.tv_sec + ts.tv_nsec / 1e9;
+ }
+
+ static void usage(const char *prog) {
+     fprintf(stderr, "Usage: %s FILE...                         replay images (AFL: %s @@)\n", prog, prog);
+     fprintf(stderr, "       %s -n ITERATIONS [-s SEED] [IMAGE]  mutate IMAGE (default vsfs.img)\n", prog);
+ }
+
+ int main(int argc, char *argv[]) {
+     long iterations = 0;
+     const char *seed_image = "vsfs.img";
+     int first_file = argc;
+
+     for (int i = 1; i < argc; i++) {
+         if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+             iterations = strtol(argv[++i], NULL, 10);
+         } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+             rng_state = strtoull(argv[++i], NULL, 10) | 1;   // xorshift state must be non-zero
+         } else if (argv[i][0] == '-') {
+             usage(argv[0]);
+             return 1;
+         } else {
+             first_file = i;
+             break;
+         }
+     }
+
+     static uint8_t input[IMAGE_SIZE];
+     quiet_stdout();
+
+     // Replay mode
+     if (iterations <= 0) {
+         if (first_file >= argc) {
+             usage(argv[0]);
+             return 1;
+         }
+         for (int i = first_file; i < argc; i++) {
+             run_one(input, load_file(argv[i], input));
+             fprintf(stderr, "%s: OK\n", argv[i]);
+         }
+         return 0;
+     }
+
+     // Mutation mode
+     static uint8_t seed[IMAGE_SIZE];
+     if (first_file < argc) {
+         seed_image = argv[first_file];
+     }
+     size_t seed_size = load_file(seed_image, seed);
+
+     double start = now_seconds();
+     double last_report = start;
+     for (long n = 1; n <= iterations; n++) {
+         memcpy(input, seed, IMAGE_SIZE);
+         mutate(input);
+
+         size_t size = seed_size > METADATA_SIZE ? seed_size : METADATA_SIZE;
+         if (rng_next() % 16 == 0) {                 // truncated image
+             size = rng_next() % (METADATA_SIZE + 1);
+         }
+         run_one(input, size);
+
+         double t = now_seconds();
+         if (t - last_report >= 1.0 || n == iterations) {
+             fprintf(stderr, "#%ld\texec/s: %.0f\n", n, n / (t - start));
+             last_report = t;
+         }
+     }
+     fprintf(stderr, "Done: %ld executions, no mismatches.\n", iterations);
+     return 0;
+ }
+
+ #endif // RAVEN_VSFS_LIBFUZZER
@@ -49,9 +49,12 @@
      uint32_t single_indirect;
      uint32_t double_indirect;
      uint32_t triple_indirect;
-     uint8_t reserved[156];               // padding for inode 256 bytes.
+     uint8_t reserved[200];               // padding for inode 256 bytes.
  } __attribute__((packed)) Inode;    // avoid padding issues
  
+ // Compile-time size checks: the on-disk structs must match their slot sizes
+ typedef char inode_size_check[sizeof(Inode) == INODE_SIZE ? 1 : -1];
+ 
  // Superblock structure
  typedef struct {
      uint16_t magic;
@@ -63,9 +66,11 @@
      uint32_t first_data_block;
      uint32_t inode_size;
      uint32_t inode_count;
-     uint8_t reserved[4058];  
+     uint8_t reserved[4062];              // padding for superblock 4096 bytes (read_block fills a whole block)
  } __attribute__((packed)) Superblock;  
  
+ typedef char superblock_size_check[sizeof(Superblock) == BLOCK_SIZE ? 1 : -1];
+ 
  
  FILE *img;
  Superblock sb;
@@ -80,10 +85,22 @@
  int errors_found = 0;
  int errors_fixed = 0;
  
+ // Individual findings are passed to REPORT_FINDING(kind, a, b, c) for the fuzz harness:
+ //   superblock: (field, 0, 0)         inode bitmap: (inode, marked used, 0)
+ //   data bitmap: (block, owner, 0)    duplicate / bad block: (inode, pointer slot, first owner / 0)
+ enum { FINDING_SUPERBLOCK, FINDING_INODE_BITMAP, FINDING_DATA_BITMAP, FINDING_DUPLICATE, FINDING_BAD_BLOCK };
+ #ifndef REPORT_FINDING
+ #define REPORT_FINDING(kind, a, b, c) ((void)0)
+ #endif
  
- void read_block(int block_num, void *buffer) {
-     fseek(img, block_num * BLOCK_SIZE, SEEK_SET);
-     fread(buffer, BLOCK_SIZE, 1, img);
+ 
+ // Returns false on a short read; bytes past the end of the image read as zeros
+ bool read_block(int block_num, void *buffer) {
+     memset(buffer, 0, BLOCK_SIZE);
+     if (fseek(img, block_num * BLOCK_SIZE, SEEK_SET) != 0) {
+         return false;
+     }
+     return fread(buffer, 1, BLOCK_SIZE, img) == BLOCK_SIZE;
  }
  
  void write_block(int block_num, void *buffer) {
@@ -124,46 +141,55 @@
      
      if (sb.magic != SUPERBLOCK_MAGIC) {
          printf("ERROR: Invalid magic number: 0x%X (should be 0x%X)\n", sb.magic, SUPERBLOCK_MAGIC);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 0, 0, 0);
          errors++;
      }
      
      if (sb.block_size != BLOCK_SIZE) {
          printf("ERROR: Invalid block size: %u (should be %u)\n", sb.block_size, BLOCK_SIZE);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 1, 0, 0);
          errors++;
      }
      
      if (sb.total_blocks != TOTAL_BLOCKS) {
          printf("ERROR: Invalid total blocks: %u (should be %u)\n", sb.total_blocks, TOTAL_BLOCKS);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 2, 0, 0);
          errors++;
      }
      
      if (sb.inode_bitmap_block != INODE_BITMAP_BLOCK) {
          printf("ERROR: Invalid inode bitmap block: %u (should be %u)\n", sb.inode_bitmap_block, INODE_BITMAP_BLOCK);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 3, 0, 0);
          errors++;
      }
      
      if (sb.data_bitmap_block != DATA_BITMAP_BLOCK) {
          printf("ERROR: Invalid data bitmap block: %u (should be %u)\n", sb.data_bitmap_block, DATA_BITMAP_BLOCK);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 4, 0, 0);
          errors++;
      }
      
      if (sb.inode_table_block != INODE_TABLE_START_BLOCK) {
          printf("ERROR: Invalid inode table block: %u (should be %u)\n", sb.inode_table_block, INODE_TABLE_START_BLOCK);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 5, 0, 0);
          errors++;
      }
      
      if (sb.first_data_block != DATA_BLOCK_START) {
          printf("ERROR: Invalid first data block: %u (should be %u)\n", sb.first_data_block, DATA_BLOCK_START);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 6, 0, 0);
          errors++;
      }
      
      if (sb.inode_size != INODE_SIZE) {
          printf("ERROR: Invalid inode size: %u (should be %u)\n", sb.inode_size, INODE_SIZE);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 7, 0, 0);
          errors++;
      }
      
      if (sb.inode_count != INODE_COUNT) {
          printf("ERROR: Invalid inode count: %u (should be %u)\n", sb.inode_count, INODE_COUNT);
+         REPORT_FINDING(FINDING_SUPERBLOCK, 8, 0, 0);
          errors++;
      }
  
@@ -178,15 +204,36 @@
  }
  
  // Load inodes from disk
- void load_inodes() {
+ bool load_inodes() {
+     bool complete = true;
+     
      for (int i = 0; i < INODE_TABLE_BLOCKS; i++) {
          uint8_t buffer[BLOCK_SIZE];
-         read_block(INODE_TABLE_START_BLOCK + i, buffer);
+         if (!read_block(INODE_TABLE_START_BLOCK + i, buffer)) {
+             complete = false;
+         }
          
          for (int j = 0; j < INODES_PER_BLOCK; j++) {
              memcpy(&inodes[i * INODES_PER_BLOCK + j], buffer + j * INODE_SIZE, sizeof(Inode));
          }
      }
+     return complete;
+ }
+ 
+ // Read superblock, bitmaps and inode table; returns false if the image is truncated
+ bool load_image() {
+     bool complete = read_block(SUPERBLOCK_BLOCK, &sb);
+     
+     if (!read_block(INODE_BITMAP_BLOCK, inode_bitmap)) {
+         complete = false;
+     }
+     if (!read_block(DATA_BITMAP_BLOCK, data_bitmap)) {
+         complete = false;
+     }
+     if (!load_inodes()) {
+         complete = false;
+     }
+     return complete;
  }
  
  // Process block pointers of an inode to track block usage
@@ -256,12 +303,14 @@
          // Case 1: Bitmap says used, but inode is not valid
          if (is_marked_used && !inode_referenced[i]) {
              printf("ERROR: Inode %d marked as used in bitmap but is not valid\n", i);
+             REPORT_FINDING(FINDING_INODE_BITMAP, i, 1, 0);
              errors++;
          }
          
          // Case 2: Bitmap says unused, but inode is valid
          if (!is_marked_used && inode_referenced[i]) {
              printf("ERROR: Inode %d is valid but marked as free in bitmap\n", i);
+             REPORT_FINDING(FINDING_INODE_BITMAP, i, 0, 0);
              errors++;
          }
      }
@@ -287,6 +336,7 @@
          // Case 1: Bitmap says used, but block is not referenced
          if (is_marked_used && !data_block_referenced[i]) {
              printf("ERROR: Data block %d marked as used in bitmap but not referenced by any inode\n", i + DATA_BLOCK_START);
+             REPORT_FINDING(FINDING_DATA_BITMAP, i + DATA_BLOCK_START, -1, 0);
              errors++;
          }
          
@@ -294,6 +344,7 @@
          if (!is_marked_used && data_block_referenced[i]) {
              printf("ERROR: Data block %d is referenced by inode %d but marked as free in bitmap\n", 
                     i + DATA_BLOCK_START, data_block_owner[i]);
+             REPORT_FINDING(FINDING_DATA_BITMAP, i + DATA_BLOCK_START, data_block_owner[i], 0);
              errors++;
          }
      }
@@ -327,6 +378,7 @@
                  if (data_block_referenced[data_idx]) {
                      printf("ERROR: Data block %d is referenced by multiple inodes (%d and %d)\n",
                             inodes[i].direct_block, data_block_owner[data_idx], i);
+                     REPORT_FINDING(FINDING_DUPLICATE, i, 0, data_block_owner[data_idx]);
                      errors++;
                  } else {
                      data_block_referenced[data_idx] = true;
@@ -341,6 +393,7 @@
                  if (data_block_referenced[data_idx]) {
                      printf("ERROR: Data block %d is referenced by multiple inodes (%d and %d)\n",
                             inodes[i].single_indirect, data_block_owner[data_idx], i);
+                     REPORT_FINDING(FINDING_DUPLICATE, i, 1, data_block_owner[data_idx]);
                      errors++;
                  } else {
                      data_block_referenced[data_idx] = true;
@@ -355,6 +408,7 @@
                  if (data_block_referenced[data_idx]) {
                      printf("ERROR: Data block %d is referenced by multiple inodes (%d and %d)\n",
                             inodes[i].double_indirect, data_block_owner[data_idx], i);
+                     REPORT_FINDING(FINDING_DUPLICATE, i, 2, data_block_owner[data_idx]);
                      errors++;
                  } else {
                      data_block_referenced[data_idx] = true;
@@ -369,6 +423,7 @@
                  if (data_block_referenced[data_idx]) {
                      printf("ERROR: Data block %d is referenced by multiple inodes (%d and %d)\n",
                             inodes[i].triple_indirect, data_block_owner[data_idx], i);
+                     REPORT_FINDING(FINDING_DUPLICATE, i, 3, data_block_owner[data_idx]);
                      errors++;
                  } else {
                      data_block_referenced[data_idx] = true;
@@ -398,24 +453,28 @@
              //direct block
              if (inodes[i].direct_block != 0 && !is_block_valid(inodes[i].direct_block)) {
                  printf("ERROR: Inode %d has invalid direct block pointer (%u)\n", i, inodes[i].direct_block);
+                 REPORT_FINDING(FINDING_BAD_BLOCK, i, 0, 0);
                  errors++;
              }
              
              // indirect block
              if (inodes[i].single_indirect != 0 && !is_block_valid(inodes[i].single_indirect)) {
                  printf("ERROR: Inode %d has invalid single indirect block pointer (%u)\n", i, inodes[i].single_indirect);
+                 REPORT_FINDING(FINDING_BAD_BLOCK, i, 1, 0);
                  errors++;
              }
              
              //  double indirect block
              if (inodes[i].double_indirect != 0 && !is_block_valid(inodes[i].double_indirect)) {
                  printf("ERROR: Inode %d has invalid double indirect block pointer (%u)\n", i, inodes[i].double_indirect);
+                 REPORT_FINDING(FINDING_BAD_BLOCK, i, 2, 0);
                  errors++;
              }
              
              // triple indirect block
              if (inodes[i].triple_indirect != 0 && !is_block_valid(inodes[i].triple_indirect)) {
                  printf("ERROR: Inode %d has invalid triple indirect block pointer (%u)\n", i, inodes[i].triple_indirect);
+                 REPORT_FINDING(FINDING_BAD_BLOCK, i, 3, 0);
                  errors++;
              }
          }
@@ -561,6 +620,8 @@
  // 1. Fix duplicate blocks by allocating new blocks and copying data
  // 2. Fix bad block references by clearing them or pointing to valid blocks
  
+ // The fuzz harness (fuzz/fuzz_vsfs.c) includes this file and drives the checks itself
+ #ifndef RAVEN_VSFS_NO_MAIN
  int main(int argc, char *argv[]) {
      char *filename = "vsfs.img";
      if (argc > 1) {
@@ -604,15 +665,10 @@
          data_block_owner[i] = -1;
      }
      
-     // Read superblock
-     read_block(SUPERBLOCK_BLOCK, &sb);
-     
-     // Read bitmaps
-     read_block(INODE_BITMAP_BLOCK, inode_bitmap);
-     read_block(DATA_BITMAP_BLOCK, data_bitmap);
-     
-     // Load inodes
-     load_inodes();
+     // Read superblock, bitmaps and inodes
+     if (!load_image()) {
+         printf("WARNING: File system image is truncated; missing blocks are read as zeros.\n");
+     }
      
      // Perform checks
      check_superblock();
@@ -663,4 +719,5 @@
      
      fclose(img);
      return 0;
- }
\ No newline at end of file
+ }
+ #endif // RAVEN_VSFS_NO_MAIN